@@ -8,6 +8,15 @@
 #include <array>
 #include <variant>
 #include <deque>
+#include <span>
+#include <thread>
+#include <limits>
+#include <algorithm>
+#include <charconv>
+#include <string_view>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
 
 #include <cmath>
 
@@ -60,6 +69,7 @@ namespace tmp
         std::string text = "";
         Operator op;
         double value = 0.0;
+        size_t offset = 0; // position of the first character in the input
 
         std::string str() const
         {
@@ -112,10 +122,1289 @@ namespace tmp
         std::string p_message;
     };
 
+    // ERROR CODES
+    enum class ErrorCode : uint8_t
+    {
+        None,
+        NoInput,
+        InputTooLong,
+        NestingTooDeep,
+        UnrecognizedCharacter,
+        UnrecognizedOperator,
+        BadNumber,
+        UnbalancedParen,
+        UnexpectedParen,
+        UnknownFunction,
+        UnknownOperator,
+        BadSymbol,
+        BadExpression,
+    };
+
+    // PARSE ERROR STRUCT -- what went wrong and where
+    struct ParseError
+    {
+        ErrorCode code = ErrorCode::None;
+        size_t offset = 0; // character offset into the input
+
+        explicit operator bool() const { return code != ErrorCode::None; }
+
+        const char *message() const
+        {
+            switch (code)
+            {
+            case ErrorCode::None:
+                return "OK";
+            case ErrorCode::NoInput:
+                return "ERROR::PARSER::NO_INPUT_PROVIDED";
+            case ErrorCode::InputTooLong:
+                return "ERROR::PARSER::INPUT_TOO_LONG";
+            case ErrorCode::NestingTooDeep:
+                return "ERROR::PARSER::NESTING_TOO_DEEP";
+            case ErrorCode::UnrecognizedCharacter:
+                return "ERROR::UNRECOGNIZED_CHARACTER";
+            case ErrorCode::UnrecognizedOperator:
+                return "ERROR::UNRECOGNIZED_OPERATOR";
+            case ErrorCode::BadNumber:
+                return "ERROR::BAD_NUMBER";
+            case ErrorCode::UnbalancedParen:
+                return "ERROR::UNBALANCED_PAREN";
+            case ErrorCode::UnexpectedParen:
+                return "ERROR::UNEXPECTED_PARANTHESIS";
+            case ErrorCode::UnknownFunction:
+                return "ERROR::UNKNOWN_FUNCTION";
+            case ErrorCode::UnknownOperator:
+                return "ERROR::UNKNOWN_OPERATOR_FOUND";
+            case ErrorCode::BadSymbol:
+                return "ERROR::BAD_SYMBOL";
+            case ErrorCode::BadExpression:
+                return "ERROR::BAD_EXPRESSION";
+            }
+            return "ERROR::UNKNOWN";
+        }
+    };
+
+    // INPUT LIMITS
+    struct Limits
+    {
+        size_t maxLength = 64 * 1024; // characters
+        size_t maxDepth = 256;        // parenthesis nesting
+
+        static constexpr Limits Unbounded()
+        {
+            return {std::numeric_limits<size_t>::max(), std::numeric_limits<size_t>::max()};
+        }
+    };
+
+    // EXPECTED -- holds either a value or the ParseError that prevented it
+    template <typename T>
+    class Expected
+    {
+    public:
+        Expected(T value) : p_data(std::move(value)) {}
+        Expected(ParseError error) : p_data(error) {}
+
+        bool has_value() const { return p_data.index() == 0; }
+        explicit operator bool() const { return has_value(); }
+
+        T &value() { return std::get<0>(p_data); }
+        const T &value() const { return std::get<0>(p_data); }
+        T &operator*() { return value(); }
+        const T &operator*() const { return value(); }
+        T *operator->() { return &value(); }
+        const T *operator->() const { return &value(); }
+
+        const ParseError &error() const { return std::get<1>(p_data); }
+
+    private:
+        std::variant<T, ParseError> p_data;
+    };
+
+    // INSTRUCTION STRUCT
+    struct Instruction
+    {
+        enum class OpCode : uint8_t
+        {
+            PushConst,
+            PushVar,
+            Add,
+            Sub,
+            Mul,
+            Div,
+            Pow,
+            Plus,
+            Neg,
+            Sin,
+            Cos,
+            Tan,
+            Sqrt,
+        } code = OpCode::PushConst;
+
+        uint32_t index = 0; // variable slot for PushVar
+        double value = 0.0; // constant for PushConst
+    };
+
+    // SUMMATION METHODS
+    enum class Summation : uint8_t
+    {
+        Naive,
+        Pairwise,
+        Kahan,
+    };
+
+    // BATCH OPTIONS
+    struct BatchOptions
+    {
+        unsigned threads = 0; // 0 -> std::thread::hardware_concurrency()
+        Summation summation = Summation::Pairwise;
+        size_t minRowsPerThread = 4096;
+    };
+
+    // ACCUMULATORS -- folded per thread, then merged
+    struct NaiveSum
+    {
+        double sum = 0.0;
+
+        void add(double v) { sum += v; }
+        void merge(const NaiveSum &other) { sum += other.sum; }
+        double result() const { return sum; }
+    };
+
+    // Kahan-Babuska (Neumaier) compensated sum
+    struct KahanSum
+    {
+        double sum = 0.0;
+        double compensation = 0.0;
+
+        void add(double v)
+        {
+            const double t = sum + v;
+            if (std::fabs(sum) >= std::fabs(v))
+                compensation += (sum - t) + v;
+            else
+                compensation += (v - t) + sum;
+            sum = t;
+        }
+        void merge(const KahanSum &other)
+        {
+            add(other.sum);
+            add(other.compensation);
+        }
+        double result() const { return sum + compensation; }
+    };
+
+    // Pairwise sum without a buffer: blocks are summed naively and then
+    // combined like a binary counter, so only log2(n) partials are kept.
+    struct PairwiseSum
+    {
+        static constexpr uint32_t BlockSize = 128;
+
+        double block = 0.0;
+        uint32_t inBlock = 0;
+        std::array<double, 64> partial{};
+        std::array<uint8_t, 64> level{};
+        uint8_t depth = 0;
+
+        void add(double v)
+        {
+            block += v;
+            if (++inBlock == BlockSize)
+            {
+                push(block, 0);
+                block = 0.0;
+                inBlock = 0;
+            }
+        }
+        void merge(const PairwiseSum &other)
+        {
+            add(other.result());
+        }
+        double result() const
+        {
+            double sum = block;
+            for (uint8_t i = depth; i > 0; i--)
+                sum = partial[i - 1] + sum;
+            return sum;
+        }
+
+    private:
+        void push(double s, uint8_t lv)
+        {
+            while (depth > 0 && level[depth - 1] == lv)
+            {
+                s = partial[--depth] + s;
+                lv++;
+            }
+            partial[depth] = s;
+            level[depth++] = lv;
+        }
+    };
+
+    // a NaN row makes the result NaN, like it does for Sum
+    struct MinAccumulator
+    {
+        double value = std::numeric_limits<double>::infinity();
+
+        void add(double v) { value = (v < value || std::isnan(v)) ? v : value; }
+        void merge(const MinAccumulator &other) { add(other.value); }
+        double result() const { return value; }
+    };
+
+    struct MaxAccumulator
+    {
+        double value = -std::numeric_limits<double>::infinity();
+
+        void add(double v) { value = (v > value || std::isnan(v)) ? v : value; }
+        void merge(const MaxAccumulator &other) { add(other.value); }
+        double result() const { return value; }
+    };
+
+    // SYMBOL TABLE -- interns variable names into ids, safe to share between threads
+    class SymbolTable
+    {
+    public:
+        uint32_t Intern(std::string_view name)
+        {
+            {
+                std::shared_lock lock(p_mutex);
+                auto found = p_ids.find(name);
+                if (found != p_ids.end())
+                    return found->second;
+            }
+
+            std::unique_lock lock(p_mutex);
+            auto found = p_ids.find(name);
+            if (found != p_ids.end())
+                return found->second;
+
+            const uint32_t id = uint32_t(p_names.size());
+            p_names.emplace_back(name);
+            p_ids.emplace(p_names.back(), id); // keyed by a view of the stored name
+            return id;
+        }
+
+        std::string_view Name(uint32_t id) const
+        {
+            std::shared_lock lock(p_mutex);
+            return p_names.at(id);
+        }
+
+        size_t Size() const
+        {
+            std::shared_lock lock(p_mutex);
+            return p_names.size();
+        }
+
+    private:
+        mutable std::shared_mutex p_mutex;
+        std::deque<std::string> p_names; // deque keeps every name at a stable address
+        std::unordered_map<std::string_view, uint32_t> p_ids;
+    };
+
+    class Compiler;
+    class Program;
+
+    inline std::vector<Expected<Program>> compileAll(std::span<const std::string_view> formulas, SymbolTable &symbols, unsigned threads = 0, const Limits &limits = {});
+
+    // COMPILED PROGRAM -- flat RPN, evaluated without per-node allocation
+    class Program
+    {
+    public:
+        using Columns = std::span<const std::span<const double>>;
+
+        const std::vector<std::string> &Variables() const { return variables; }
+        // SymbolTable id of each variable, filled in by compileAll
+        const std::vector<uint32_t> &Symbols() const { return symbols; }
+        const std::vector<Instruction> &Code() const { return code; }
+        size_t StackSize() const { return stackSize; }
+
+        // values[i] is the value of Variables()[i], stack holds StackSize() doubles
+        double Run(const double *values, double *stack) const
+        {
+            size_t top = 0;
+            for (const auto &inst : code)
+            {
+                switch (inst.code)
+                {
+                case Instruction::OpCode::PushConst:
+                    stack[top++] = inst.value;
+                    break;
+                case Instruction::OpCode::PushVar:
+                    stack[top++] = values[inst.index];
+                    break;
+                case Instruction::OpCode::Add:
+                    top--;
+                    stack[top - 1] = stack[top - 1] + stack[top];
+                    break;
+                case Instruction::OpCode::Sub:
+                    top--;
+                    stack[top - 1] = stack[top - 1] - stack[top];
+                    break;
+                case Instruction::OpCode::Mul:
+                    top--;
+                    stack[top - 1] = stack[top - 1] * stack[top];
+                    break;
+                case Instruction::OpCode::Div:
+                    top--;
+                    stack[top - 1] = stack[top - 1] / stack[top];
+                    break;
+                case Instruction::OpCode::Pow:
+                    top--;
+                    stack[top - 1] = raisedTo(stack[top - 1], stack[top]);
+                    break;
+                case Instruction::OpCode::Plus:
+                    break;
+                case Instruction::OpCode::Neg:
+                    stack[top - 1] = -stack[top - 1];
+                    break;
+                case Instruction::OpCode::Sin:
+                    stack[top - 1] = std::sin(stack[top - 1]);
+                    break;
+                case Instruction::OpCode::Cos:
+                    stack[top - 1] = std::cos(stack[top - 1]);
+                    break;
+                case Instruction::OpCode::Tan:
+                    stack[top - 1] = std::tan(stack[top - 1]);
+                    break;
+                case Instruction::OpCode::Sqrt:
+                    stack[top - 1] = std::sqrt(stack[top - 1]);
+                    break;
+                }
+            }
+            return stack[0];
+        }
+
+        double Evaluate(const std::vector<double> &values) const
+        {
+            if (values.size() != variables.size())
+                throw CompileError("ERROR::PROGRAM::VARIABLE_COUNT_MISMATCH");
+            std::vector<double> stack(stackSize);
+            return Run(values.data(), stack.data());
+        }
+
+        // BATCH EVALUATION
+        // rows holds count rows of Variables().size() values each, results go to out.
+        // Each instruction runs across a tile of rows before the next one starts.
+        void EvaluateBatch(const double *rows, size_t count, double *out) const
+        {
+            const size_t width = variables.size();
+            std::vector<double> stack(stackSize * Lanes);
+
+            for (size_t base = 0; base < count; base += Lanes)
+            {
+                const size_t n = std::min(Lanes, count - base);
+                const double *tile = rows + base * width;
+                RunTile([&](uint32_t index, size_t i)
+                        { return tile[i * width + index]; },
+                        n, stack.data());
+                std::copy(stack.data(), stack.data() + n, out + base);
+            }
+        }
+
+        // FUSED REDUCTIONS
+        // columns[i] holds the values of Variables()[i], one entry per row.
+        // Rows are evaluated and folded straight into per-thread accumulators,
+        // no result buffer is materialized. A NaN row makes Sum, Mean, Min and
+        // Max NaN. The row count comes from the columns, so a program without
+        // variables is rejected with ERROR::BATCH::NO_VARIABLES.
+        double Sum(Columns columns, BatchOptions options = {}) const
+        {
+            switch (options.summation)
+            {
+            case Summation::Naive:
+                return Reduce<NaiveSum>(columns, options).result();
+            case Summation::Kahan:
+                return Reduce<KahanSum>(columns, options).result();
+            case Summation::Pairwise:
+            default:
+                return Reduce<PairwiseSum>(columns, options).result();
+            }
+        }
+
+        double Mean(Columns columns, BatchOptions options = {}) const
+        {
+            const size_t rows = RowCount(columns);
+            if (rows == 0)
+                return std::numeric_limits<double>::quiet_NaN();
+            return Sum(columns, options) / double(rows);
+        }
+
+        double Min(Columns columns, BatchOptions options = {}) const
+        {
+            return Reduce<MinAccumulator>(columns, options).result();
+        }
+
+        double Max(Columns columns, BatchOptions options = {}) const
+        {
+            return Reduce<MaxAccumulator>(columns, options).result();
+        }
+
+        template <typename Predicate>
+        size_t CountIf(Columns columns, Predicate pred, BatchOptions options = {}) const
+        {
+            struct CountAccumulator
+            {
+                Predicate pred;
+                size_t count = 0;
+
+                void add(double v) { count += pred(v) ? 1 : 0; }
+                void merge(const CountAccumulator &other) { count += other.count; }
+            };
+            return Reduce<CountAccumulator>(columns, options, CountAccumulator{pred}).count;
+        }
+
+    private:
+        friend class Compiler;
+        friend std::vector<Expected<Program>> compileAll(std::span<const std::string_view>, SymbolTable &, unsigned, const Limits &);
+
+        std::vector<Instruction> code;
+        std::vector<std::string> variables;
+        std::vector<uint32_t> symbols;
+        size_t stackSize = 0;
+
+        size_t RowCount(Columns columns) const
+        {
+            if (columns.size() != variables.size())
+                throw CompileError("ERROR::BATCH::COLUMN_COUNT_MISMATCH");
+            if (columns.empty())
+                throw CompileError("ERROR::BATCH::NO_VARIABLES");
+            for (const auto &col : columns)
+            {
+                if (col.size() != columns[0].size())
+                    throw CompileError("ERROR::BATCH::COLUMN_LENGTH_MISMATCH");
+            }
+            return columns[0].size();
+        }
+
+        static constexpr size_t Lanes = 64;
+
+        // Runs the program over n <= Lanes rows, load(index, i) gives variable
+        // index of row i. The results end up in stack[0 .. n).
+        template <typename Load>
+        void RunTile(Load load, size_t n, double *stack) const
+        {
+            auto slot = [&](size_t k)
+            { return stack + k * Lanes; };
+            size_t top = 0;
+
+            for (const auto &inst : code)
+            {
+                double *a = top ? slot(top - 1) : nullptr;
+                const double *b = nullptr;
+                switch (inst.code)
+                {
+                case Instruction::OpCode::PushConst:
+                    a = slot(top++);
+                    for (size_t i = 0; i < n; i++)
+                        a[i] = inst.value;
+                    break;
+                case Instruction::OpCode::PushVar:
+                    a = slot(top++);
+                    for (size_t i = 0; i < n; i++)
+                        a[i] = load(inst.index, i);
+                    break;
+                case Instruction::OpCode::Add:
+                    top--;
+                    a = slot(top - 1);
+                    b = slot(top);
+                    for (size_t i = 0; i < n; i++)
+                        a[i] = a[i] + b[i];
+                    break;
+                case Instruction::OpCode::Sub:
+                    top--;
+                    a = slot(top - 1);
+                    b = slot(top);
+                    for (size_t i = 0; i < n; i++)
+                        a[i] = a[i] - b[i];
+                    break;
+                case Instruction::OpCode::Mul:
+                    top--;
+                    a = slot(top - 1);
+                    b = slot(top);
+                    for (size_t i = 0; i < n; i++)
+                        a[i] = a[i] * b[i];
+                    break;
+                case Instruction::OpCode::Div:
+                    top--;
+                    a = slot(top - 1);
+                    b = slot(top);
+                    for (size_t i = 0; i < n; i++)
+                        a[i] = a[i] / b[i];
+                    break;
+                case Instruction::OpCode::Pow:
+                    top--;
+                    a = slot(top - 1);
+                    b = slot(top);
+                    for (size_t i = 0; i < n; i++)
+                        a[i] = raisedTo(a[i], b[i]);
+                    break;
+                case Instruction::OpCode::Plus:
+                    break;
+                case Instruction::OpCode::Neg:
+                    for (size_t i = 0; i < n; i++)
+                        a[i] = -a[i];
+                    break;
+                case Instruction::OpCode::Sin:
+                    for (size_t i = 0; i < n; i++)
+                        a[i] = std::sin(a[i]);
+                    break;
+                case Instruction::OpCode::Cos:
+                    for (size_t i = 0; i < n; i++)
+                        a[i] = std::cos(a[i]);
+                    break;
+                case Instruction::OpCode::Tan:
+                    for (size_t i = 0; i < n; i++)
+                        a[i] = std::tan(a[i]);
+                    break;
+                case Instruction::OpCode::Sqrt:
+                    for (size_t i = 0; i < n; i++)
+                        a[i] = std::sqrt(a[i]);
+                    break;
+                }
+            }
+        }
+
+        // evaluates a tile at a time and folds it into a local accumulator,
+        // the shared partial is written once at the end
+        template <typename Accumulator>
+        void Fold(Columns columns, size_t begin, size_t end, Accumulator &partial) const
+        {
+            Accumulator acc = partial;
+            std::vector<double> stack(stackSize * Lanes);
+            for (size_t base = begin; base < end; base += Lanes)
+            {
+                const size_t n = std::min(Lanes, end - base);
+                RunTile([&](uint32_t index, size_t i)
+                        { return columns[index][base + i]; },
+                        n, stack.data());
+                for (size_t i = 0; i < n; i++)
+                    acc.add(stack[i]);
+            }
+            partial = acc;
+        }
+
+        template <typename Accumulator>
+        Accumulator Reduce(Columns columns, const BatchOptions &options, Accumulator init = {}) const
+        {
+            const size_t rows = RowCount(columns);
+
+            size_t threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+            const size_t perThread = options.minRowsPerThread ? options.minRowsPerThread : 1;
+            threads = std::max<size_t>(1, std::min(threads, rows / perThread));
+
+            std::vector<Accumulator> partial(threads, init);
+            if (threads == 1)
+            {
+                Fold(columns, 0, rows, partial[0]);
+                return partial[0];
+            }
+
+            std::vector<std::thread> workers;
+            workers.reserve(threads - 1);
+            const size_t chunk = rows / threads;
+            for (size_t t = 1; t < threads; t++)
+            {
+                const size_t begin = t * chunk;
+                const size_t end = (t + 1 == threads) ? rows : begin + chunk;
+                workers.emplace_back([&, t, begin, end]
+                                     { Fold(columns, begin, end, partial[t]); });
+            }
+            Fold(columns, 0, chunk, partial[0]);
+
+            for (auto &w : workers)
+                w.join();
+            for (size_t t = 1; t < threads; t++)
+                partial[0].merge(partial[t]);
+            return partial[0];
+        }
+    };
+
+    // REGISTER INSTRUCTION STRUCT
+    struct RegInstruction
+    {
+        enum class OpCode : uint8_t
+        {
+            LoadConst, // dst = k
+            LoadVar,   // dst = values[var]
+            Add,       // dst = a + b
+            Sub,
+            Mul,
+            Div,
+            Pow,
+            Neg, // dst = -a
+            Sin,
+            Cos,
+            Tan,
+            Sqrt,
+            AddVar, // dst = a + values[var]
+            SubVar, // dst = a - values[var]
+            VarSub, // dst = values[var] - a
+            MulVar,
+            DivVar,
+            VarDiv,
+            AddConst, // dst = a + k
+            SubConst, // dst = a - k
+            ConstSub, // dst = k - a
+            MulConst,
+            DivConst,
+            ConstDiv,
+            Fma,    // dst = fma(a, b, c)
+            Fms,    // dst = fma(a, b, -c)
+            Horner, // dst = polynomial in values[var], coefficients[pool .. pool + degree]
+        } code = OpCode::LoadConst;
+
+        uint32_t dst = 0;
+        uint32_t a = 0;
+        uint32_t b = 0;
+        uint32_t c = 0;
+        uint32_t var = 0;
+        uint32_t pool = 0;   // first coefficient of a Horner instruction
+        uint32_t degree = 0; // degree of a Horner instruction
+        double k = 0.0;
+    };
+
+    // REGISTER PROGRAM -- register machine lowered from a Program's RPN.
+    // Constants are folded, common shapes become superinstructions (operand
+    // from a variable or constant, a*b+c as fma, single variable polynomials
+    // in Horner form) and registers are reused once their value is dead.
+    // Horner form is only used for polynomials already written as sums of
+    // distinct c*x*...*x terms, and only when it runs fewer steps than the tree.
+    // Factored products are never multiplied out and like terms never merged.
+    //
+    // Results are not bit for bit those of Program::Run:
+    // - fma rounds a*b+c once. When a*b and c cancel, the result keeps the
+    //   rounding error of a*b, so 9*x-x*9 may give 1e-13 instead of 0. The
+    //   error is bounded by an ulp of a*b, not of the result.
+    // - Horner orders the work differently, so near overflow one side can get
+    //   inf where the other gets NaN (x*x*x*x-x*x*x at x=1e200).
+    class RegisterProgram
+    {
+    public:
+        explicit RegisterProgram(const Program &program) : variables(program.Variables())
+        {
+            Lower(program.Code());
+        }
+
+        const std::vector<std::string> &Variables() const { return variables; }
+        const std::vector<RegInstruction> &Code() const { return code; }
+        const std::vector<double> &Coefficients() const { return coefficients; }
+        size_t RegisterCount() const { return registerCount; }
+
+        // values[i] is the value of Variables()[i], regs holds RegisterCount() doubles
+        double Run(const double *values, double *regs) const
+        {
+            for (const auto &in : code)
+            {
+                switch (in.code)
+                {
+                case RegInstruction::OpCode::LoadConst:
+                    regs[in.dst] = in.k;
+                    break;
+                case RegInstruction::OpCode::LoadVar:
+                    regs[in.dst] = values[in.var];
+                    break;
+                case RegInstruction::OpCode::Add:
+                    regs[in.dst] = regs[in.a] + regs[in.b];
+                    break;
+                case RegInstruction::OpCode::Sub:
+                    regs[in.dst] = regs[in.a] - regs[in.b];
+                    break;
+                case RegInstruction::OpCode::Mul:
+                    regs[in.dst] = regs[in.a] * regs[in.b];
+                    break;
+                case RegInstruction::OpCode::Div:
+                    regs[in.dst] = regs[in.a] / regs[in.b];
+                    break;
+                case RegInstruction::OpCode::Pow:
+                    regs[in.dst] = raisedTo(regs[in.a], regs[in.b]);
+                    break;
+                case RegInstruction::OpCode::Neg:
+                    regs[in.dst] = -regs[in.a];
+                    break;
+                case RegInstruction::OpCode::Sin:
+                    regs[in.dst] = std::sin(regs[in.a]);
+                    break;
+                case RegInstruction::OpCode::Cos:
+                    regs[in.dst] = std::cos(regs[in.a]);
+                    break;
+                case RegInstruction::OpCode::Tan:
+                    regs[in.dst] = std::tan(regs[in.a]);
+                    break;
+                case RegInstruction::OpCode::Sqrt:
+                    regs[in.dst] = std::sqrt(regs[in.a]);
+                    break;
+                case RegInstruction::OpCode::AddVar:
+                    regs[in.dst] = regs[in.a] + values[in.var];
+                    break;
+                case RegInstruction::OpCode::SubVar:
+                    regs[in.dst] = regs[in.a] - values[in.var];
+                    break;
+                case RegInstruction::OpCode::VarSub:
+                    regs[in.dst] = values[in.var] - regs[in.a];
+                    break;
+                case RegInstruction::OpCode::MulVar:
+                    regs[in.dst] = regs[in.a] * values[in.var];
+                    break;
+                case RegInstruction::OpCode::DivVar:
+                    regs[in.dst] = regs[in.a] / values[in.var];
+                    break;
+                case RegInstruction::OpCode::VarDiv:
+                    regs[in.dst] = values[in.var] / regs[in.a];
+                    break;
+                case RegInstruction::OpCode::AddConst:
+                    regs[in.dst] = regs[in.a] + in.k;
+                    break;
+                case RegInstruction::OpCode::SubConst:
+                    regs[in.dst] = regs[in.a] - in.k;
+                    break;
+                case RegInstruction::OpCode::ConstSub:
+                    regs[in.dst] = in.k - regs[in.a];
+                    break;
+                case RegInstruction::OpCode::MulConst:
+                    regs[in.dst] = regs[in.a] * in.k;
+                    break;
+                case RegInstruction::OpCode::DivConst:
+                    regs[in.dst] = regs[in.a] / in.k;
+                    break;
+                case RegInstruction::OpCode::ConstDiv:
+                    regs[in.dst] = in.k / regs[in.a];
+                    break;
+                case RegInstruction::OpCode::Fma:
+                    regs[in.dst] = std::fma(regs[in.a], regs[in.b], regs[in.c]);
+                    break;
+                case RegInstruction::OpCode::Fms:
+                    regs[in.dst] = std::fma(regs[in.a], regs[in.b], -regs[in.c]);
+                    break;
+                case RegInstruction::OpCode::Horner:
+                {
+                    const double x = values[in.var];
+                    const double *coeff = coefficients.data() + in.pool;
+                    double r = coeff[0];
+                    for (uint32_t i = 1; i <= in.degree; i++)
+                        r = std::fma(r, x, coeff[i]);
+                    regs[in.dst] = r;
+                    break;
+                }
+                }
+            }
+            return regs[resultRegister];
+        }
+
+        double Evaluate(const std::vector<double> &values) const
+        {
+            if (values.size() != variables.size())
+                throw CompileError("ERROR::PROGRAM::VARIABLE_COUNT_MISMATCH");
+            std::vector<double> regs(registerCount);
+            return Run(values.data(), regs.data());
+        }
+
+    private:
+        using Op = Instruction::OpCode;
+        using RegOp = RegInstruction::OpCode;
+
+        static constexpr uint32_t None = UINT32_MAX;
+        static constexpr size_t MaxPolynomialDegree = 16;
+
+        // how a node is turned into instructions
+        enum class Form : uint8_t
+        {
+            Leaf,      // LoadConst / LoadVar
+            Unary,     // op a
+            Registers, // op a, b
+            LeftLeaf,  // left child read directly as a variable or constant
+            RightLeaf, // right child read directly as a variable or constant
+            Fused,     // Fma / Fms
+            Horner,
+        };
+
+        // EXPRESSION TREE NODE
+        struct Node
+        {
+            Op op = Op::PushConst;
+            uint32_t left = None;
+            uint32_t right = None;
+            uint32_t index = 0; // variable slot
+            double value = 0.0; // constant
+
+            Form form = Form::Leaf;
+            uint32_t cost = 1; // instructions needed to produce this node
+            uint32_t need = 1; // registers needed to produce this node
+
+            // polynomial in a single variable, lowest power first
+            bool isPolynomial = false;
+            uint32_t polyVar = None;
+            std::vector<double> poly;
+        };
+
+        std::vector<RegInstruction> code;
+        std::vector<std::string> variables;
+        std::vector<double> coefficients;
+        size_t registerCount = 0;
+        uint32_t resultRegister = 0;
+
+        std::vector<Node> nodes;
+        uint32_t virtualCount = 0;
+
+        bool IsLeaf(uint32_t n) const
+        {
+            return nodes[n].op == Op::PushConst || nodes[n].op == Op::PushVar;
+        }
+
+        static double Fold(Op op, double a, double b)
+        {
+            switch (op)
+            {
+            case Op::Add:
+                return a + b;
+            case Op::Sub:
+                return a - b;
+            case Op::Mul:
+                return a * b;
+            case Op::Div:
+                return a / b;
+            case Op::Pow:
+                return raisedTo(a, b);
+            case Op::Neg:
+                return -a;
+            case Op::Sin:
+                return std::sin(a);
+            case Op::Cos:
+                return std::cos(a);
+            case Op::Tan:
+                return std::tan(a);
+            case Op::Sqrt:
+                return std::sqrt(a);
+            default:
+                return a;
+            }
+        }
+
+        void Lower(const std::vector<Instruction> &rpn)
+        {
+            // an empty Program gives NaN, like a register that was never written
+            if (rpn.empty())
+            {
+                RegInstruction in;
+                in.k = std::numeric_limits<double>::quiet_NaN();
+                code.push_back(in);
+                registerCount = 1;
+                return;
+            }
+
+            // BUILD TREE
+            std::vector<uint32_t> stack;
+            for (const auto &inst : rpn)
+            {
+                Node node;
+                node.op = inst.code;
+                switch (inst.code)
+                {
+                case Op::PushConst:
+                    node.value = inst.value;
+                    break;
+                case Op::PushVar:
+                    node.index = inst.index;
+                    break;
+                case Op::Plus:
+                    continue;
+                case Op::Add:
+                case Op::Sub:
+                case Op::Mul:
+                case Op::Div:
+                case Op::Pow:
+                    node.right = stack.back();
+                    stack.pop_back();
+                    node.left = stack.back();
+                    stack.pop_back();
+                    break;
+                default:
+                    node.left = stack.back();
+                    stack.pop_back();
+                    break;
+                }
+
+                // constant folding
+                const bool leftConst = node.left != None && nodes[node.left].op == Op::PushConst;
+                const bool rightConst = node.right == None || nodes[node.right].op == Op::PushConst;
+                if (leftConst && rightConst)
+                {
+                    const double b = node.right == None ? 0.0 : nodes[node.right].value;
+                    const double value = Fold(node.op, nodes[node.left].value, b);
+                    node = Node();
+                    node.op = Op::PushConst;
+                    node.value = value;
+                }
+
+                nodes.push_back(std::move(node));
+                Select(uint32_t(nodes.size() - 1));
+                stack.push_back(uint32_t(nodes.size() - 1));
+            }
+
+            // EMIT on virtual registers, then map them onto real ones
+            const uint32_t result = Emit(stack.back());
+            Allocate(result);
+            nodes.clear();
+        }
+
+        // INSTRUCTION SELECTION -- cheapest form by executed steps, children already selected
+        void Select(uint32_t n)
+        {
+            Node &node = nodes[n];
+            Polynomial(node);
+
+            if (node.op == Op::PushConst || node.op == Op::PushVar)
+                return;
+
+            SelectTree(node);
+
+            // Horner runs one fma per degree, so it has to beat the tree form.
+            // A single c*x^n term is left to MulVar / MulConst.
+            if (node.isPolynomial && node.polyVar != None && node.poly.size() > 2 && Terms(node.poly) > 1)
+            {
+                const uint32_t degree = uint32_t(node.poly.size() - 1);
+                if (degree < node.cost)
+                {
+                    node.form = Form::Horner;
+                    node.cost = degree;
+                    node.need = 1;
+                }
+            }
+        }
+
+        void SelectTree(Node &node)
+        {
+            const Node &l = nodes[node.left];
+            if (node.right == None)
+            {
+                node.form = Form::Unary;
+                node.cost = l.cost + 1;
+                node.need = l.need;
+                return;
+            }
+
+            const Node &r = nodes[node.right];
+            node.form = Form::Registers;
+            node.cost = l.cost + r.cost + 1;
+            node.need = l.need == r.need ? l.need + 1 : std::max(l.need, r.need);
+
+            // a*b+c, c+a*b and a*b-c
+            auto tryFused = [&](const Node &mul, const Node &other)
+            {
+                const Node &p = nodes[mul.left];
+                const Node &q = nodes[mul.right];
+                const uint32_t cost = p.cost + q.cost + other.cost + 1;
+                if (cost <= node.cost)
+                {
+                    std::array<uint32_t, 3> needs{p.need, q.need, other.need};
+                    std::sort(needs.begin(), needs.end(), std::greater<>());
+                    node.form = Form::Fused;
+                    node.cost = cost;
+                    node.need = std::max({needs[0], needs[1] + 1, needs[2] + 2});
+                }
+            };
+
+            if (node.op != Op::Pow)
+            {
+                if (IsLeaf(node.right) && l.cost + 1 < node.cost)
+                {
+                    node.form = Form::RightLeaf;
+                    node.cost = l.cost + 1;
+                    node.need = l.need;
+                }
+                if (IsLeaf(node.left) && r.cost + 1 < node.cost)
+                {
+                    node.form = Form::LeftLeaf;
+                    node.cost = r.cost + 1;
+                    node.need = r.need;
+                }
+            }
+
+            if (node.op == Op::Add && l.op == Op::Mul && l.form != Form::Horner)
+                tryFused(l, r);
+            else if (node.op == Op::Add && r.op == Op::Mul && r.form != Form::Horner)
+                tryFused(r, l);
+            else if (node.op == Op::Sub && l.op == Op::Mul && l.form != Form::Horner)
+                tryFused(l, r);
+        }
+
+        static size_t Terms(const std::vector<double> &poly)
+        {
+            return size_t(std::count_if(poly.begin(), poly.end(), [](double c)
+                                        { return c != 0.0; }));
+        }
+
+        // POLYNOMIAL RECOGNITION over + - * and negation. A product is only
+        // taken when one side is a constant or both are single c*x^n terms,
+        // so (x-a)*(x-b) keeps its factored form and its precision. A sum is
+        // only taken when no power appears on both sides, so like terms are
+        // never merged and x*x-x*x still cancels the way Program does.
+        void Polynomial(Node &node)
+        {
+            switch (node.op)
+            {
+            case Op::PushConst:
+                node.isPolynomial = true;
+                node.poly = {node.value};
+                return;
+            case Op::PushVar:
+                node.isPolynomial = true;
+                node.polyVar = node.index;
+                node.poly = {0.0, 1.0};
+                return;
+            case Op::Neg:
+            {
+                const Node &l = nodes[node.left];
+                if (!l.isPolynomial)
+                    return;
+                node.isPolynomial = true;
+                node.polyVar = l.polyVar;
+                node.poly = l.poly;
+                for (auto &c : node.poly)
+                    c = -c;
+                return;
+            }
+            case Op::Add:
+            case Op::Sub:
+            case Op::Mul:
+                break;
+            default:
+                return;
+            }
+
+            const Node &l = nodes[node.left];
+            const Node &r = nodes[node.right];
+            if (!l.isPolynomial || !r.isPolynomial)
+                return;
+            if (l.polyVar != None && r.polyVar != None && l.polyVar != r.polyVar)
+                return;
+
+            std::vector<double> poly;
+            if (node.op == Op::Mul)
+            {
+                const bool scaled = l.poly.size() == 1 || r.poly.size() == 1;
+                if (!scaled && (Terms(l.poly) > 1 || Terms(r.poly) > 1))
+                    return;
+
+                poly.assign(l.poly.size() + r.poly.size() - 1, 0.0);
+                for (size_t i = 0; i < l.poly.size(); i++)
+                    for (size_t j = 0; j < r.poly.size(); j++)
+                        poly[i + j] += l.poly[i] * r.poly[j];
+            }
+            else
+            {
+                for (size_t i = 0; i < std::min(l.poly.size(), r.poly.size()); i++)
+                {
+                    if (l.poly[i] != 0.0 && r.poly[i] != 0.0)
+                        return;
+                }
+
+                const double sign = node.op == Op::Sub ? -1.0 : 1.0;
+                poly.assign(std::max(l.poly.size(), r.poly.size()), 0.0);
+                for (size_t i = 0; i < l.poly.size(); i++)
+                    poly[i] += l.poly[i];
+                for (size_t i = 0; i < r.poly.size(); i++)
+                    poly[i] += sign * r.poly[i];
+            }
+            while (poly.size() > 1 && poly.back() == 0.0)
+                poly.pop_back();
+            if (poly.size() > MaxPolynomialDegree + 1)
+                return;
+
+            node.isPolynomial = true;
+            node.polyVar = l.polyVar != None ? l.polyVar : r.polyVar;
+            node.poly = std::move(poly);
+        }
+
+        // CODE GENERATION -- children needing more registers go first
+        uint32_t Emit(uint32_t n)
+        {
+            const Node &node = nodes[n];
+            RegInstruction in;
+
+            switch (node.form)
+            {
+            case Form::Leaf:
+                if (node.op == Op::PushConst)
+                {
+                    in.code = RegOp::LoadConst;
+                    in.k = node.value;
+                }
+                else
+                {
+                    in.code = RegOp::LoadVar;
+                    in.var = node.index;
+                }
+                break;
+
+            case Form::Horner:
+                in.code = RegOp::Horner;
+                in.var = node.polyVar;
+                in.pool = uint32_t(coefficients.size());
+                in.degree = uint32_t(node.poly.size() - 1);
+                coefficients.insert(coefficients.end(), node.poly.rbegin(), node.poly.rend());
+                break;
+
+            case Form::Unary:
+                in.a = Emit(node.left);
+                in.code = node.op == Op::Neg    ? RegOp::Neg
+                          : node.op == Op::Sin  ? RegOp::Sin
+                          : node.op == Op::Cos  ? RegOp::Cos
+                          : node.op == Op::Tan  ? RegOp::Tan
+                                                : RegOp::Sqrt;
+                break;
+
+            case Form::Registers:
+                if (nodes[node.left].need >= nodes[node.right].need)
+                {
+                    in.a = Emit(node.left);
+                    in.b = Emit(node.right);
+                }
+                else
+                {
+                    in.b = Emit(node.right);
+                    in.a = Emit(node.left);
+                }
+                in.code = node.op == Op::Add   ? RegOp::Add
+                          : node.op == Op::Sub ? RegOp::Sub
+                          : node.op == Op::Mul ? RegOp::Mul
+                          : node.op == Op::Div ? RegOp::Div
+                                               : RegOp::Pow;
+                break;
+
+            case Form::RightLeaf:
+            case Form::LeftLeaf:
+            {
+                const bool right = node.form == Form::RightLeaf;
+                const Node &leaf = nodes[right ? node.right : node.left];
+                in.a = Emit(right ? node.left : node.right);
+                const bool isVar = leaf.op == Op::PushVar;
+                in.var = leaf.index;
+                in.k = leaf.value;
+                switch (node.op)
+                {
+                case Op::Add:
+                    in.code = isVar ? RegOp::AddVar : RegOp::AddConst;
+                    break;
+                case Op::Mul:
+                    in.code = isVar ? RegOp::MulVar : RegOp::MulConst;
+                    break;
+                case Op::Sub:
+                    in.code = right ? (isVar ? RegOp::SubVar : RegOp::SubConst) : (isVar ? RegOp::VarSub : RegOp::ConstSub);
+                    break;
+                default: // Div
+                    in.code = right ? (isVar ? RegOp::DivVar : RegOp::DivConst) : (isVar ? RegOp::VarDiv : RegOp::ConstDiv);
+                    break;
+                }
+                break;
+            }
+
+            case Form::Fused:
+            {
+                // same preference as Select: the left product first
+                const bool leftMul = nodes[node.left].op == Op::Mul && nodes[node.left].form != Form::Horner;
+                const Node &mul = nodes[leftMul ? node.left : node.right];
+                const uint32_t other = leftMul ? node.right : node.left;
+
+                // highest register need first
+                std::array<std::pair<uint32_t, uint32_t *>, 3> order{{{mul.left, &in.a}, {mul.right, &in.b}, {other, &in.c}}};
+                std::stable_sort(order.begin(), order.end(), [&](const auto &x, const auto &y)
+                                 { return nodes[x.first].need > nodes[y.first].need; });
+                for (auto &[child, reg] : order)
+                    *reg = Emit(child);
+                in.code = node.op == Op::Add ? RegOp::Fma : RegOp::Fms;
+                break;
+            }
+            }
+
+            in.dst = virtualCount++;
+            code.push_back(in);
+            return in.dst;
+        }
+
+        // LIVENESS + REGISTER ALLOCATION
+        // Every virtual register is written once; its real register is
+        // released after the last instruction that reads it.
+        void Allocate(uint32_t result)
+        {
+            auto reads = [](RegInstruction &in, auto &&visit)
+            {
+                switch (in.code)
+                {
+                case RegOp::LoadConst:
+                case RegOp::LoadVar:
+                case RegOp::Horner:
+                    break;
+                case RegOp::Add:
+                case RegOp::Sub:
+                case RegOp::Mul:
+                case RegOp::Div:
+                case RegOp::Pow:
+                    visit(in.a);
+                    visit(in.b);
+                    break;
+                case RegOp::Fma:
+                case RegOp::Fms:
+                    visit(in.a);
+                    visit(in.b);
+                    visit(in.c);
+                    break;
+                default:
+                    visit(in.a);
+                    break;
+                }
+            };
+
+            std::vector<uint32_t> lastUse(virtualCount, 0);
+            for (uint32_t i = 0; i < code.size(); i++)
+                reads(code[i], [&](uint32_t &v)
+                      { lastUse[v] = i; });
+            lastUse[result] = uint32_t(code.size());
+
+            std::vector<uint32_t> physical(virtualCount, 0);
+            std::vector<bool> busy;
+            for (uint32_t i = 0; i < code.size(); i++)
+            {
+                auto &in = code[i];
+                reads(in, [&](uint32_t &v)
+                      {
+                    const uint32_t p = physical[v];
+                    if (lastUse[v] == i)
+                        busy[p] = false;
+                    v = p; });
+
+                uint32_t p = 0;
+                while (p < busy.size() && busy[p])
+                    p++;
+                if (p == busy.size())
+                    busy.push_back(false);
+                busy[p] = true;
+                physical[in.dst] = p;
+                in.dst = p;
+            }
+
+            registerCount = busy.size();
+            resultRegister = physical[result];
+        }
+    };
+
     class Compiler
     {
     protected:
-        std::unordered_map<std::string, Operator> mapOperators;
+        // shared by every Compiler, never modified after start up.
+        // It used to be a per-object map, subclasses can no longer add operators to it.
+        static inline const std::unordered_map<std::string, Operator> mapOperators = {
+            {"*", {3, 2}},
+            {"/", {3, 2}},
+            {"+", {1, 2}},
+            {"-", {1, 2}},
+            {"^", {4, 2}},
+        };
+
+        static inline const std::unordered_map<std::string, Instruction::OpCode> mapFunctions = {
+            {"sin", Instruction::OpCode::Sin},
+            {"cos", Instruction::OpCode::Cos},
+            {"tan", Instruction::OpCode::Tan},
+            {"sqrt", Instruction::OpCode::Sqrt},
+        };
 
         // HOLDERS
         std::deque<Token> holding_stack;
@@ -125,24 +1414,33 @@ namespace tmp
         std::unordered_map<std::string, bool> FunctionName;
 
     public:
-        Compiler()
+        Compiler() = default;
+
+        std::vector<Token> Parse(const std::string &input)
         {
-            mapOperators["*"] = {3, 2};
-            mapOperators["/"] = {3, 2};
-            mapOperators["+"] = {1, 2};
-            mapOperators["-"] = {1, 2};
-            mapOperators["^"] = {4, 2};
+            std::vector<Token> vecOutputTokens;
+            const ParseError error = TryParse(input, vecOutputTokens, Limits::Unbounded());
+            if (error)
+            {
+                throw CompileError(error.message());
+            }
+            return vecOutputTokens;
         }
 
-        std::vector<Token> Parse(const std::string &input)
+        // Non-throwing tokeniser, every problem is reported with its character offset
+        ParseError TryParse(std::string_view input, std::vector<Token> &vecOutputTokens, const Limits &limits = {})
         {
             // ERROR HANDLING
             if (input.empty())
             {
-                throw CompileError("ERROR::PARSER::NO_INPUT_PROVIDED");
+                return {ErrorCode::NoInput, 0};
+            }
+            if (input.size() > limits.maxLength)
+            {
+                return {ErrorCode::InputTooLong, limits.maxLength};
             }
 
-            std::vector<Token> vecOutputTokens;
+            vecOutputTokens.clear();
 
             // FINITE STATE MACHINE
             enum class TokeniserState : uint8_t
@@ -162,62 +1460,74 @@ namespace tmp
             Token tokCurrent;
 
             size_t ParenthesisBalanceChecker = 0;
-            auto charNow = input.begin();
-            while (charNow != input.end())
+            std::vector<size_t> openOffsets; // where each still open parenthesis is
+            size_t tokenStart = 0;
+            size_t charNow = 0;
+            // the end of input reads as '\0', which no LUT accepts, so the last token completes on its own
+            while (charNow < input.size() || stateNow != TokeniserState::NewToken)
             {
+                const uint8_t c = charNow < input.size() ? uint8_t(input[charNow]) : 0;
+
                 switch (stateNow)
                 {
                 case TokeniserState::NewToken:
                     // Reset State
                     sCurrentToken.clear();
                     tokCurrent = {Token::Type::Unknown, ""};
+                    tokenStart = charNow;
 
                     // First character Analysis
                     // checking white space
-                    if (lut::WhiteSpaceDigits.at(charNow[0]))
+                    if (lut::WhiteSpaceDigits.at(c))
                     {
                         charNow++;
                         stateNext = TokeniserState::NewToken;
                     }
 
                     // checking numeric literals
-                    else if (lut::NumericDigits.at(charNow[0]))
+                    else if (lut::NumericDigits.at(c))
                     {
-                        sCurrentToken = charNow[0];
+                        sCurrentToken = char(c);
                         stateNext = TokeniserState::Numeric_Literal; // switch to numeric literal state
                         charNow++;
                     }
 
                     // checking Operators
-                    else if (lut::OperatorDigits.at(charNow[0]))
+                    else if (lut::OperatorDigits.at(c))
                     {
                         stateNext = TokeniserState::Operator;
                     }
                     // checking Parenthesis Open
-                    else if (charNow[0] == '(')
+                    else if (c == '(')
                     {
                         stateNext = TokeniserState::Parenthesis_Open;
                     }
                     // checking Parenthesis Close
-                    else if (charNow[0] == ')')
+                    else if (c == ')')
                     {
                         stateNext = TokeniserState::Parenthesis_Close;
                     }
 
-                    else if (lut::Alphabets.at(charNow[0]))
+                    else if (lut::Alphabets.at(c))
                     {
-                        sCurrentToken = charNow[0];
+                        sCurrentToken = char(c);
                         stateNext = TokeniserState::String_Literal;
                         charNow++;
                     }
 
+                    // nothing accepts this character
+                    else
+                    {
+                        return {ErrorCode::UnrecognizedCharacter, charNow};
+                    }
+
                     break; // OUT NEW_STATE
 
                 // Numeric_Literal
                 case TokeniserState::Numeric_Literal:
-                    if (lut::RealNumericDigits.at(charNow[0]))
+                    if (lut::RealNumericDigits.at(c))
                     {
-                        sCurrentToken += charNow[0];
+                        sCurrentToken += char(c);
                         charNow++;
                         stateNext = TokeniserState::Numeric_Literal;
                     }
@@ -225,18 +1535,23 @@ namespace tmp
                     {
                         stateNext = TokeniserState::CompleteToken;
                         tokCurrent = {Token::Type::Literal_Numeric, sCurrentToken};
-                        tokCurrent.value = std::stod(sCurrentToken);
+                        const char *last = sCurrentToken.data() + sCurrentToken.size();
+                        const auto [ptr, ec] = std::from_chars(sCurrentToken.data(), last, tokCurrent.value);
+                        if (ec != std::errc() || ptr != last)
+                        {
+                            return {ErrorCode::BadNumber, tokenStart};
+                        }
                     }
                     break;
                 // Operators
                 case TokeniserState::Operator:
-                    if (lut::OperatorDigits.at(charNow[0]))
+                    if (lut::OperatorDigits.at(c))
                     {
                         // if this + next is an operator
-                        if (mapOperators.contains(sCurrentToken + charNow[0]))
+                        if (mapOperators.contains(sCurrentToken + char(c)))
                         {
                             // YES - add the next to this
-                            sCurrentToken += charNow[0];
+                            sCurrentToken += char(c);
                             charNow++;
                         }
                         else
@@ -244,12 +1559,12 @@ namespace tmp
                             if (mapOperators.contains(sCurrentToken))
                             {
                                 tokCurrent = {Token::Type::Operator, sCurrentToken};
-                                tokCurrent.op = mapOperators[sCurrentToken];
+                                tokCurrent.op = mapOperators.at(sCurrentToken);
                                 stateNext = TokeniserState::CompleteToken;
                             }
                             else
                             {
-                                sCurrentToken += charNow[0];
+                                sCurrentToken += char(c);
                                 charNow++;
                             }
                         }
@@ -259,19 +1574,24 @@ namespace tmp
                         if (mapOperators.contains(sCurrentToken))
                         {
                             tokCurrent = {Token::Type::Operator, sCurrentToken};
-                            tokCurrent.op = mapOperators[sCurrentToken];
+                            tokCurrent.op = mapOperators.at(sCurrentToken);
                             stateNext = TokeniserState::CompleteToken;
                         }
                         else
                         {
-                            throw CompileError("ERROR::UNRECOGNIZED_OPERATOR");
+                            return {ErrorCode::UnrecognizedOperator, tokenStart};
                         }
                     }
                     break;
 
                 // Parenthesis
                 case TokeniserState::Parenthesis_Open:
-                    sCurrentToken += charNow[0];
+                    if (ParenthesisBalanceChecker >= limits.maxDepth)
+                    {
+                        return {ErrorCode::NestingTooDeep, charNow};
+                    }
+                    openOffsets.push_back(charNow);
+                    sCurrentToken += char(c);
                     charNow++;
                     ParenthesisBalanceChecker++;
                     tokCurrent = {Token::Type::Paranthesis_Open, sCurrentToken};
@@ -279,7 +1599,13 @@ namespace tmp
                     break;
 
                 case TokeniserState::Parenthesis_Close:
-                    sCurrentToken += charNow[0];
+                    // a close with nothing open would underflow the counter
+                    if (ParenthesisBalanceChecker == 0)
+                    {
+                        return {ErrorCode::UnexpectedParen, charNow};
+                    }
+                    openOffsets.pop_back();
+                    sCurrentToken += char(c);
                     charNow++;
                     ParenthesisBalanceChecker--;
                     tokCurrent = {Token::Type::Paranthesis_Close, sCurrentToken};
@@ -288,9 +1614,9 @@ namespace tmp
 
                 // String
                 case TokeniserState::String_Literal:
-                    if (lut::Alphabets.at(charNow[0]))
+                    if (lut::Alphabets.at(c))
                     {
-                        sCurrentToken += charNow[0];
+                        sCurrentToken += char(c);
                         charNow++;
                     }
                     else
@@ -310,6 +1636,7 @@ namespace tmp
                     break;
                 // Completed
                 case TokeniserState::CompleteToken:
+                    tokCurrent.offset = tokenStart;
                     vecOutputTokens.push_back(tokCurrent);
                     stateNext = TokeniserState::NewToken;
                     break;
@@ -320,15 +1647,21 @@ namespace tmp
 
             if (ParenthesisBalanceChecker != 0)
             {
-                throw CompileError("ERROR::UNBALANCED_PAREN");
+                return {ErrorCode::UnbalancedParen, openOffsets.back()};
             }
 
-            return vecOutputTokens;
+            return {};
         }
 
-        double Evaluate(std::vector<Token> inputExpression)
+    protected:
+        // SHUNTING YARD -- converts the token stream into RPN inside output_stack
+        ParseError TryShuntingYard(const std::vector<Token> &inputExpression)
         {
-            for (auto tok : inputExpression)
+            holding_stack.clear();
+            output_stack.clear();
+            solving_stack.clear();
+
+            for (const auto &tok : inputExpression)
             {
                 // Literal_Numeric
                 if (tok.type == Token::Type::Literal_Numeric)
@@ -357,7 +1690,7 @@ namespace tmp
                                 break;
                         }
                         else
-                            throw CompileError("ERROR::UNKNOWN_OPERATOR_FOUND");
+                            return {ErrorCode::UnknownOperator, tok.offset};
                     }
                     holding_stack.push_front(tok);
                 }
@@ -378,7 +1711,7 @@ namespace tmp
                     // holding stack becomes empty :: error
                     if (holding_stack.empty())
                     {
-                        throw CompileError("ERROR::UNEXPECTED_PARANTHESIS");
+                        return {ErrorCode::UnexpectedParen, tok.offset};
                     }
                     // if holding stack has parenthesis
                     // remove the corresponding openPara from holding stack
@@ -386,6 +1719,12 @@ namespace tmp
                     {
                         holding_stack.pop_front();
                     }
+                    // a function right before the openPara owns this parenthesis
+                    if (!holding_stack.empty() && holding_stack.front().type == Token::Type::Function)
+                    {
+                        output_stack.push_back(holding_stack.front());
+                        holding_stack.pop_front();
+                    }
                 }
                 // Variable
                 else if (tok.type == Token::Type::Variable)
@@ -400,7 +1739,7 @@ namespace tmp
                 // Unknown
                 else
                 {
-                    throw CompileError("ERROR::BAD_SYMBOL");
+                    return {ErrorCode::BadSymbol, tok.offset};
                 }
             }
             // Draining the holding stack
@@ -409,6 +1748,22 @@ namespace tmp
                 output_stack.push_back(holding_stack.front());
                 holding_stack.pop_front();
             }
+            return {};
+        }
+
+        void ShuntingYard(const std::vector<Token> &inputExpression)
+        {
+            const ParseError error = TryShuntingYard(inputExpression);
+            if (error)
+            {
+                throw CompileError(error.message());
+            }
+        }
+
+    public:
+        double Evaluate(std::vector<Token> inputExpression)
+        {
+            ShuntingYard(inputExpression);
 
             // quick TEST -- printing RPN
             // std::cout << "\nRPN: ";
@@ -507,6 +1862,119 @@ namespace tmp
             return solving_stack[0];
         }
 
+        // Lowers the expression into a flat Program that can be evaluated many times
+        Program Compile(const std::vector<Token> &inputExpression)
+        {
+            ShuntingYard(inputExpression);
+
+            Program program;
+            const ParseError error = TryLower(program);
+            if (error)
+            {
+                throw CompileError(error.message());
+            }
+            return program;
+        }
+
+        // Non-throwing Parse + Compile for untrusted input
+        Expected<Program> tryCompile(std::string_view input, const Limits &limits = {})
+        {
+            std::vector<Token> tokens;
+            ParseError error = TryParse(input, tokens, limits);
+            if (!error)
+                error = TryShuntingYard(tokens);
+
+            Program program;
+            if (!error)
+                error = TryLower(program);
+
+            if (error)
+                return error;
+            return program;
+        }
+
+    protected:
+        // RPN in output_stack -> Program::code
+        ParseError TryLower(Program &program)
+        {
+            program.code.reserve(output_stack.size());
+
+            size_t depth = 0;
+            for (const auto &inst : output_stack)
+            {
+                Instruction ins;
+                uint8_t pops = 0;
+                switch (inst.type)
+                {
+                case Token::Type::Literal_Numeric:
+                    ins.code = Instruction::OpCode::PushConst;
+                    ins.value = inst.value;
+                    break;
+
+                case Token::Type::Variable:
+                {
+                    auto &vars = program.variables;
+                    auto found = std::find(vars.begin(), vars.end(), inst.text);
+                    ins.code = Instruction::OpCode::PushVar;
+                    ins.index = uint32_t(found - vars.begin());
+                    if (found == vars.end())
+                        vars.push_back(inst.text);
+                    break;
+                }
+
+                case Token::Type::Function:
+                {
+                    pops = 1;
+                    auto found = mapFunctions.find(inst.text);
+                    if (found == mapFunctions.end())
+                        return {ErrorCode::UnknownFunction, inst.offset};
+                    ins.code = found->second;
+                    break;
+                }
+
+                case Token::Type::Operator:
+                    pops = inst.op.arguement;
+                    if (pops == 2 && inst.text == "+")
+                        ins.code = Instruction::OpCode::Add;
+                    else if (pops == 2 && inst.text == "-")
+                        ins.code = Instruction::OpCode::Sub;
+                    else if (pops == 2 && inst.text == "*")
+                        ins.code = Instruction::OpCode::Mul;
+                    else if (pops == 2 && inst.text == "/")
+                        ins.code = Instruction::OpCode::Div;
+                    else if (pops == 2 && inst.text == "^")
+                        ins.code = Instruction::OpCode::Pow;
+                    else if (pops == 1 && inst.text == "+")
+                        ins.code = Instruction::OpCode::Plus;
+                    else if (pops == 1 && inst.text == "-")
+                        ins.code = Instruction::OpCode::Neg;
+                    else
+                        return {ErrorCode::UnknownOperator, inst.offset};
+                    break;
+
+                default:
+                    return {ErrorCode::BadSymbol, inst.offset};
+                }
+
+                // stack depth is checked here once, so Program::Run never has to
+                if (depth < pops)
+                    return {ErrorCode::BadExpression, inst.offset};
+                depth = depth - pops + 1;
+                program.stackSize = std::max(program.stackSize, depth);
+                program.code.push_back(ins);
+            }
+
+            if (depth != 1)
+            {
+                const size_t offset = output_stack.empty() ? 0 : output_stack.back().offset;
+                return {ErrorCode::BadExpression, offset};
+            }
+
+            return {};
+        }
+
+    public:
+
         void setVariableValue(std::vector<Token> &tokVec, std::string variableName, double value)
         {
             for (auto &token : tokVec)
@@ -519,6 +1987,63 @@ namespace tmp
         }
     };
 
+    // BULK COMPILATION
+    // Compiles every formula across threads. Each thread has its own Compiler,
+    // all of them share the operator tables and the symbol table. A bad formula
+    // only fails its own entry. Tokens and Programs still allocate their own
+    // strings, so the threads also share the allocator.
+    inline std::vector<Expected<Program>> compileAll(std::span<const std::string_view> formulas, SymbolTable &symbols, unsigned threads, const Limits &limits)
+    {
+        std::vector<Expected<Program>> results(formulas.size(), Expected<Program>(ParseError{}));
+
+        constexpr size_t Chunk = 64;
+        std::atomic<size_t> next = 0;
+
+        auto work = [&]
+        {
+            Compiler compiler;
+            std::unordered_map<std::string, uint32_t> seen; // saves a trip to the shared table
+            while (true)
+            {
+                const size_t begin = next.fetch_add(Chunk, std::memory_order_relaxed);
+                if (begin >= formulas.size())
+                    return;
+                const size_t end = std::min(begin + Chunk, formulas.size());
+
+                for (size_t f = begin; f < end; f++)
+                {
+                    auto result = compiler.tryCompile(formulas[f], limits);
+                    if (result)
+                    {
+                        Program &program = *result;
+                        program.symbols.reserve(program.variables.size());
+                        for (const auto &name : program.variables)
+                        {
+                            auto [found, inserted] = seen.try_emplace(name, 0);
+                            if (inserted)
+                                found->second = symbols.Intern(name);
+                            program.symbols.push_back(found->second);
+                        }
+                    }
+                    results[f] = std::move(result);
+                }
+            }
+        };
+
+        size_t count = threads ? threads : std::thread::hardware_concurrency();
+        count = std::max<size_t>(1, std::min(count, (formulas.size() + Chunk - 1) / Chunk));
+
+        std::vector<std::thread> workers;
+        workers.reserve(count - 1);
+        for (size_t t = 1; t < count; t++)
+            workers.emplace_back(work);
+        work();
+        for (auto &w : workers)
+            w.join();
+
+        return results;
+    }
+
     static inline double raisedTo(double num1, double num2)
     {
         double sum = num1;
@@ -0,0 +1,273 @@
+#ifndef TINY_MATH_SERVER_H
+#define TINY_MATH_SERVER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <span>
+
+#include "TinyMathParser.h"
+
+// EVALUATION SERVER
+namespace tmp
+{
+    // SERVER OPTIONS
+    struct ServerOptions
+    {
+        unsigned workers = 0;                         // 0 -> std::thread::hardware_concurrency()
+        size_t maxBatch = 256;                        // requests handed to one worker at most
+        std::chrono::microseconds latencyBudget{200}; // longest a request waits for its batch to fill
+        Limits limits;                                // applied to registered expressions
+    };
+
+    // In-process front end: requests are queued, collected into micro-batches
+    // and evaluated with Program::EvaluateBatch on a fixed worker pool.
+    class EvalServer
+    {
+    public:
+        using Reply = std::function<void(double)>;
+
+        explicit EvalServer(ServerOptions options = {}) : p_options(options)
+        {
+            if (p_options.maxBatch == 0)
+                p_options.maxBatch = 1;
+
+            unsigned workers = p_options.workers ? p_options.workers : std::thread::hardware_concurrency();
+            workers = workers ? workers : 1;
+            for (unsigned w = 0; w < workers; w++)
+                p_workers.emplace_back([this]
+                                       { WorkerLoop(); });
+            p_dispatcher = std::thread([this]
+                                       { DispatchLoop(); });
+        }
+
+        ~EvalServer()
+        {
+            Stop();
+        }
+
+        EvalServer(const EvalServer &) = delete;
+        EvalServer &operator=(const EvalServer &) = delete;
+
+        // Compiles and caches the expression under id, replacing any previous one
+        ParseError Register(uint64_t id, std::string_view expression)
+        {
+            Compiler compiler;
+            auto result = compiler.tryCompile(expression, p_options.limits);
+            if (!result)
+                return result.error();
+
+            auto program = std::make_shared<const Program>(std::move(*result));
+            std::unique_lock lock(p_cacheMutex);
+            p_cache[id] = std::move(program);
+            return {};
+        }
+
+        // Variable names of a registered expression, in the order Submit expects values
+        std::vector<std::string> Variables(uint64_t id) const
+        {
+            auto program = Find(id);
+            return program ? program->Variables() : std::vector<std::string>{};
+        }
+
+        // Queues one evaluation, reply is called from a worker thread with the result.
+        // Returns false when the id is unknown, the value count is wrong or the server is stopping.
+        // An exception thrown by reply is swallowed. reply must not call Stop(),
+        // the worker running it would have to join itself.
+        bool Submit(uint64_t id, std::span<const double> values, Reply reply)
+        {
+            auto program = Find(id);
+            if (!program || values.size() != program->Variables().size())
+                return false;
+
+            bool wake = false;
+            {
+                std::lock_guard lock(p_queueMutex);
+                if (p_stopping)
+                    return false;
+                p_queue.push_back({id, std::move(program), {values.begin(), values.end()}, std::move(reply), Clock::now()});
+                // the dispatcher only cares about the first request and a full batch
+                wake = p_queue.size() == 1 || p_queue.size() == p_options.maxBatch;
+            }
+            if (wake)
+                p_queueReady.notify_one();
+            return true;
+        }
+
+        std::future<double> Submit(uint64_t id, std::span<const double> values)
+        {
+            auto promise = std::make_shared<std::promise<double>>();
+            auto future = promise->get_future();
+            if (!Submit(id, values, [promise](double v)
+                        { promise->set_value(v); }))
+            {
+                promise->set_exception(std::make_exception_ptr(CompileError("ERROR::SERVER::REQUEST_REJECTED")));
+            }
+            return future;
+        }
+
+        // Flushes every queued request, then joins all threads
+        void Stop()
+        {
+            {
+                std::lock_guard lock(p_queueMutex);
+                if (p_stopping)
+                    return;
+                p_stopping = true;
+            }
+            p_queueReady.notify_all();
+            p_dispatcher.join();
+
+            {
+                std::lock_guard lock(p_jobMutex);
+                p_jobsDone = true;
+            }
+            p_jobReady.notify_all();
+            for (auto &w : p_workers)
+                w.join();
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        // REQUEST STRUCT
+        struct Request
+        {
+            uint64_t id = 0;
+            std::shared_ptr<const Program> program;
+            std::vector<double> values;
+            Reply reply;
+            Clock::time_point arrival;
+        };
+
+        // a run of requests for the same expression
+        struct Job
+        {
+            std::shared_ptr<const Program> program;
+            std::vector<Request> requests;
+        };
+
+        ServerOptions p_options;
+
+        // COMPILED EXPRESSION CACHE
+        mutable std::shared_mutex p_cacheMutex;
+        std::unordered_map<uint64_t, std::shared_ptr<const Program>> p_cache;
+
+        // INCOMING QUEUE
+        std::mutex p_queueMutex;
+        std::condition_variable p_queueReady;
+        std::deque<Request> p_queue;
+        bool p_stopping = false;
+
+        // WORKER POOL
+        std::mutex p_jobMutex;
+        std::condition_variable p_jobReady;
+        std::deque<Job> p_jobs;
+        bool p_jobsDone = false;
+
+        std::thread p_dispatcher;
+        std::vector<std::thread> p_workers;
+
+        std::shared_ptr<const Program> Find(uint64_t id) const
+        {
+            std::shared_lock lock(p_cacheMutex);
+            auto found = p_cache.find(id);
+            return found == p_cache.end() ? nullptr : found->second;
+        }
+
+        // Waits until maxBatch requests are queued or the oldest one has used
+        // its latency budget, then splits the batch by expression id.
+        void DispatchLoop()
+        {
+            std::vector<Request> batch;
+            while (true)
+            {
+                {
+                    std::unique_lock lock(p_queueMutex);
+                    p_queueReady.wait(lock, [this]
+                                      { return p_stopping || !p_queue.empty(); });
+                    if (p_queue.empty())
+                        return; // stopping and fully drained
+
+                    const auto deadline = p_queue.front().arrival + p_options.latencyBudget;
+                    p_queueReady.wait_until(lock, deadline, [this]
+                                            { return p_stopping || p_queue.size() >= p_options.maxBatch; });
+
+                    const size_t take = std::min(p_queue.size(), p_options.maxBatch);
+                    batch.assign(std::make_move_iterator(p_queue.begin()), std::make_move_iterator(p_queue.begin() + take));
+                    p_queue.erase(p_queue.begin(), p_queue.begin() + take);
+                }
+
+                std::unordered_map<const Program *, Job> groups;
+                for (auto &req : batch)
+                {
+                    auto &job = groups[req.program.get()];
+                    if (!job.program)
+                        job.program = req.program;
+                    job.requests.push_back(std::move(req));
+                }
+                batch.clear();
+
+                {
+                    std::lock_guard lock(p_jobMutex);
+                    for (auto &[program, job] : groups)
+                        p_jobs.push_back(std::move(job));
+                }
+                p_jobReady.notify_all();
+            }
+        }
+
+        void WorkerLoop()
+        {
+            std::vector<double> rows;
+            std::vector<double> results;
+            while (true)
+            {
+                Job job;
+                {
+                    std::unique_lock lock(p_jobMutex);
+                    p_jobReady.wait(lock, [this]
+                                    { return p_jobsDone || !p_jobs.empty(); });
+                    if (p_jobs.empty())
+                        return;
+                    job = std::move(p_jobs.front());
+                    p_jobs.pop_front();
+                }
+
+                const size_t width = job.program->Variables().size();
+                const size_t count = job.requests.size();
+                rows.resize(count * width);
+                results.resize(count);
+                for (size_t r = 0; r < count; r++)
+                    std::copy(job.requests[r].values.begin(), job.requests[r].values.end(), rows.begin() + r * width);
+
+                job.program->EvaluateBatch(rows.data(), count, results.data());
+
+                for (size_t r = 0; r < count; r++)
+                {
+                    // one bad callback must not take the worker, and the server, down
+                    try
+                    {
+                        job.requests[r].reply(results[r]);
+                    }
+                    catch (...)
+                    {
+                    }
+                }
+            }
+        }
+    };
+
+} // namespace tmp
+
+#endif
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "TinyMathParser.h"
+
+// Checks compileAll against one tryCompile per formula, returns non zero if any case fails.
+int main()
+{
+    size_t failed = 0;
+    auto check = [&](bool ok, const std::string &what)
+    {
+        if (!ok)
+        {
+            failed++;
+            std::cout << "FAILED: " << what << '\n';
+        }
+    };
+
+    // valid and broken formulas mixed, sharing variable names between them
+    const std::vector<std::string> shapes = {"a*x+b", "sin(x)*cos(y)+z", "(a+b)*(c-d)/e", "sqrt(x*x+y*y)",
+                                             "1+(2*(3", "3 # 4", "2)", "foo(x)", "1.2.3", "p+q*r-s/t"};
+    std::vector<std::string> storage;
+    for (size_t i = 0; i < 5000; i++)
+        storage.push_back(shapes[i % shapes.size()] + (i % 3 ? "+" + std::to_string(i) : ""));
+    const std::vector<std::string_view> formulas(storage.begin(), storage.end());
+
+    tmp::SymbolTable symbols;
+    const auto programs = tmp::compileAll(formulas, symbols, 4);
+    check(programs.size() == formulas.size(), "one result per formula");
+
+    tmp::Compiler compiler;
+    std::unordered_map<std::string, uint32_t> ids;
+    for (size_t f = 0; f < formulas.size(); f++)
+    {
+        const auto single = compiler.tryCompile(formulas[f]);
+        const auto &bulk = programs[f];
+        const std::string tag = " for \"" + storage[f] + "\"";
+
+        if (bool(single) != bool(bulk))
+        {
+            check(false, "success differs" + tag);
+            continue;
+        }
+        if (!single)
+        {
+            check(single.error().code == bulk.error().code, "error code" + tag);
+            check(single.error().offset == bulk.error().offset, "error offset" + tag);
+            continue;
+        }
+
+        check(single->Variables() == bulk->Variables(), "variables" + tag);
+        check(bulk->Symbols().size() == bulk->Variables().size(), "one symbol per variable" + tag);
+        std::vector<double> values(single->Variables().size(), 0.75);
+        check(single->Evaluate(values) == bulk->Evaluate(values), "result" + tag);
+
+        for (size_t v = 0; v < bulk->Symbols().size() && v < bulk->Variables().size(); v++)
+        {
+            const std::string &name = bulk->Variables()[v];
+            const uint32_t id = bulk->Symbols()[v];
+            check(symbols.Name(id) == name, "Name(id) round trip of " + name + tag);
+            auto [found, inserted] = ids.try_emplace(name, id);
+            check(found->second == id, "same id for " + name + tag);
+        }
+    }
+    check(symbols.Size() == ids.size(), "no symbol is interned twice");
+
+    std::cout << (failed ? "some checks failed\n" : "all bulk compile checks passed\n");
+    return failed ? 1 : 0;
+}
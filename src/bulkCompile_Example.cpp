@@ -0,0 +1,46 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <thread>
+#include "TinyMathParser.h"
+
+// usage: bulkCompile [formulas] [threads]
+int main(int argc, char *argv[])
+{
+    const size_t count = argc > 1 ? std::stoul(argv[1]) : 200000;
+    const unsigned threads = argc > 2 ? std::stoul(argv[2]) : std::thread::hardware_concurrency();
+
+    // a synthetic formula set, every 100th one is broken on purpose
+    const std::vector<std::string> shapes = {"a*x+b", "sin(x)*cos(y)+z", "(a+b)*(c-d)/e", "sqrt(x*x+y*y)", "p^2+q*r-s/t"};
+    std::vector<std::string> storage;
+    storage.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        std::string formula = shapes[i % shapes.size()] + "+" + std::to_string(i);
+        if (i % 100 == 99)
+            formula += ")";
+        storage.push_back(std::move(formula));
+    }
+    std::vector<std::string_view> formulas(storage.begin(), storage.end());
+
+    using Clock = std::chrono::steady_clock;
+    for (unsigned t : {1u, threads})
+    {
+        tmp::SymbolTable symbols;
+        const auto start = Clock::now();
+        const auto programs = tmp::compileAll(formulas, symbols, t);
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        size_t failed = 0;
+        for (const auto &p : programs)
+            failed += p ? 0 : 1;
+
+        std::cout << "threads = " << t << " : " << seconds * 1e3 << " ms, "
+                  << size_t(double(count) / seconds) << " formulas/s, "
+                  << failed << " failed, " << symbols.Size() << " symbols\n";
+    }
+
+    return 0;
+}
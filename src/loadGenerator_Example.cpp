@@ -0,0 +1,98 @@
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <cmath>
+#include "TinyMathServer.h"
+
+// usage: loadGenerator [clients] [requests_per_client] [latency_budget_us] [in_flight_per_client]
+int main(int argc, char *argv[])
+{
+    const unsigned clients = argc > 1 ? std::stoul(argv[1]) : 4;
+    const size_t perClient = argc > 2 ? std::stoul(argv[2]) : 100000;
+    const long budget = argc > 3 ? std::stol(argv[3]) : 200;
+    const size_t window = argc > 4 ? std::stoul(argv[4]) : 64;
+
+    tmp::ServerOptions options;
+    options.latencyBudget = std::chrono::microseconds(budget);
+    tmp::EvalServer server(options);
+
+    const std::vector<std::string> expressions = {"x*y+z", "sin(x)+cos(y)", "(a+b)*(a-b)/c", "sqrt(x*x+y*y)"};
+    for (uint64_t id = 0; id < expressions.size(); id++)
+    {
+        const auto error = server.Register(id, expressions[id]);
+        if (error)
+        {
+            std::cout << expressions[id] << " : " << error.message() << '\n';
+            return 1;
+        }
+    }
+
+    std::vector<size_t> widths;
+    for (uint64_t id = 0; id < expressions.size(); id++)
+        widths.push_back(server.Variables(id).size());
+
+    using Clock = std::chrono::steady_clock;
+    // microseconds, NaN marks a request the server rejected
+    std::vector<std::vector<double>> latencies(clients, std::vector<double>(perClient, std::numeric_limits<double>::quiet_NaN()));
+    std::atomic<size_t> completed = 0;
+    std::atomic<size_t> rejected = 0;
+
+    const auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned c = 0; c < clients; c++)
+    {
+        threads.emplace_back([&, c]
+                             {
+            std::atomic<size_t> inFlight = 0;
+            std::vector<double> values(3);
+            for (size_t r = 0; r < perClient; r++)
+            {
+                while (inFlight.load(std::memory_order_acquire) >= window)
+                    std::this_thread::yield();
+
+                const uint64_t id = r % expressions.size();
+                values.assign({double(r), 0.5, 2.0});
+                values.resize(widths[id]);
+
+                const auto sent = Clock::now();
+                inFlight++;
+                const bool accepted = server.Submit(id, values, [&, sent, r](double)
+                                                    {
+                    latencies[c][r] = std::chrono::duration<double, std::micro>(Clock::now() - sent).count();
+                    completed++;
+                    inFlight--; });
+                if (!accepted)
+                {
+                    inFlight--;
+                    rejected++;
+                }
+            }
+            while (inFlight.load(std::memory_order_acquire) != 0)
+                std::this_thread::yield(); });
+    }
+    for (auto &t : threads)
+        t.join();
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    server.Stop();
+
+    std::vector<double> all;
+    for (const auto &l : latencies)
+        std::copy_if(l.begin(), l.end(), std::back_inserter(all), [](double v)
+                     { return !std::isnan(v); });
+    std::sort(all.begin(), all.end());
+
+    std::cout << "requests   = " << completed << '\n';
+    std::cout << "rejected   = " << rejected << '\n';
+    std::cout << "throughput = " << size_t(double(completed) / seconds) << " req/s\n";
+    if (all.empty())
+        return 0;
+    std::cout << "p50        = " << all[all.size() / 2] << " us\n";
+    std::cout << "p99        = " << all[all.size() * 99 / 100] << " us\n";
+
+    return 0;
+}
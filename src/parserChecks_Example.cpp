@@ -0,0 +1,66 @@
+#include <iostream>
+#include <string>
+#include "TinyMathParser.h"
+
+// Regression checks for tryCompile, returns non zero if any case fails.
+int main()
+{
+    struct Case
+    {
+        std::string input;
+        tmp::ErrorCode code;
+        size_t offset;
+        double result; // checked when code is None
+    };
+
+    const std::vector<Case> cases = {
+        {std::string("x\x01", 2), tmp::ErrorCode::UnrecognizedCharacter, 1, 0.0}, // used to loop forever
+        {"2)", tmp::ErrorCode::UnexpectedParen, 1, 0.0},                          // used to underflow the counter
+        {"(1+2))(", tmp::ErrorCode::UnexpectedParen, 5, 0.0},
+        {"1.2.3", tmp::ErrorCode::BadNumber, 0, 0.0},
+        {"3 # 4", tmp::ErrorCode::UnrecognizedOperator, 2, 0.0},
+        {"1+(2*(3", tmp::ErrorCode::UnbalancedParen, 5, 0.0}, // innermost open parenthesis
+        {"((((1))))", tmp::ErrorCode::NestingTooDeep, 3, 0.0},
+        {std::string(65, '1'), tmp::ErrorCode::InputTooLong, 64, 0.0},
+        {"", tmp::ErrorCode::NoInput, 0, 0.0},
+        {"3+", tmp::ErrorCode::BadExpression, 1, 0.0},
+        {"foo(2)", tmp::ErrorCode::UnknownFunction, 0, 0.0},
+        {"3*4+2", tmp::ErrorCode::None, 0, 14.0}, // last token without a trailing space
+        {"3*4+2 ", tmp::ErrorCode::None, 0, 14.0},
+        {"(((1)))+sqrt(16)", tmp::ErrorCode::None, 0, 5.0},
+    };
+
+    const tmp::Limits limits{64, 3};
+    tmp::Compiler compiler;
+    size_t failed = 0;
+
+    for (const auto &c : cases)
+    {
+        const auto result = compiler.tryCompile(c.input, limits);
+        const tmp::ErrorCode code = result ? tmp::ErrorCode::None : result.error().code;
+
+        bool ok = code == c.code;
+        if (ok && !result)
+            ok = result.error().offset == c.offset;
+        if (ok && result)
+            ok = result->Evaluate(std::vector<double>(result->Variables().size())) == c.result;
+
+        if (!ok)
+        {
+            failed++;
+            std::cout << "FAILED: \"" << c.input << "\" -> "
+                      << (result ? "ok" : result.error().message()) << " @"
+                      << (result ? 0 : result.error().offset) << '\n';
+        }
+    }
+
+    // the throwing path keeps working without a trailing space
+    if (compiler.Evaluate(compiler.Parse("3*4+2")) != 14.0)
+    {
+        failed++;
+        std::cout << "FAILED: Parse/Evaluate \"3*4+2\"\n";
+    }
+
+    std::cout << cases.size() + 1 - failed << " passed, " << failed << " failed\n";
+    return failed ? 1 : 0;
+}
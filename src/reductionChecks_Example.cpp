@@ -0,0 +1,96 @@
+#include <iostream>
+#include <vector>
+#include <span>
+#include <cmath>
+#include "TinyMathParser.h"
+
+// Regression checks for the Program reductions, returns non zero if any case fails.
+int main()
+{
+    size_t failed = 0;
+    auto check = [&](bool ok, const std::string &what)
+    {
+        if (!ok)
+        {
+            failed++;
+            std::cout << "FAILED: " << what << '\n';
+        }
+    };
+
+    tmp::Compiler compiler;
+    const tmp::Program program = compiler.Compile(compiler.Parse("sin(x)*3-y/2"));
+
+    // 1000 + 37 rows: not a multiple of the 64 row tile, split over several threads
+    const size_t rows = 1037;
+    std::vector<double> xs(rows), ys(rows);
+    for (size_t r = 0; r < rows; r++)
+    {
+        xs[r] = 0.01 * double(r);
+        ys[r] = 1.0 + double(r % 17);
+    }
+    std::vector<std::span<const double>> columns{xs, ys};
+
+    // reference: one row at a time
+    double sum = 0.0;
+    double lowest = INFINITY;
+    double highest = -INFINITY;
+    size_t positive = 0;
+    for (size_t r = 0; r < rows; r++)
+    {
+        const double v = program.Evaluate({xs[r], ys[r]});
+        sum += v;
+        lowest = std::min(lowest, v);
+        highest = std::max(highest, v);
+        positive += v > 0 ? 1 : 0;
+    }
+    auto close = [](double a, double b)
+    { return std::fabs(a - b) <= 1e-12 * std::max(1.0, std::fabs(b)); };
+
+    for (unsigned threads : {1u, 3u, 8u})
+    {
+        const std::string tag = " threads=" + std::to_string(threads);
+        for (auto summation : {tmp::Summation::Naive, tmp::Summation::Pairwise, tmp::Summation::Kahan})
+        {
+            const tmp::BatchOptions options{threads, summation, 1};
+            check(close(program.Sum(columns, options), sum), "Sum summation=" + std::to_string(int(summation)) + tag);
+            check(close(program.Mean(columns, options), sum / double(rows)), "Mean summation=" + std::to_string(int(summation)) + tag);
+        }
+
+        const tmp::BatchOptions options{threads, tmp::Summation::Pairwise, 1};
+        check(program.Min(columns, options) == lowest, "Min" + tag);
+        check(program.Max(columns, options) == highest, "Max" + tag);
+        check(program.CountIf(columns, [](double v)
+                              { return v > 0; }, options) == positive,
+              "CountIf" + tag);
+    }
+
+    // a NaN row poisons Min and Max instead of being skipped
+    std::vector<double> withNaN = xs;
+    withNaN[500] = NAN;
+    std::vector<std::span<const double>> nanColumns{withNaN, ys};
+    const tmp::BatchOptions options{4, tmp::Summation::Pairwise, 1};
+    check(std::isnan(program.Min(nanColumns, options)), "Min with NaN row");
+    check(std::isnan(program.Max(nanColumns, options)), "Max with NaN row");
+    check(std::isnan(program.Sum(nanColumns, options)), "Sum with NaN row");
+
+    // no rows
+    std::vector<std::span<const double>> empty{std::span<const double>(), std::span<const double>()};
+    check(program.Sum(empty) == 0.0, "Sum of no rows");
+    check(std::isnan(program.Mean(empty)), "Mean of no rows");
+
+    // a program without variables has no row count
+    const tmp::Program constant = compiler.Compile(compiler.Parse("2*3"));
+    bool rejected = false;
+    try
+    {
+        constant.Sum({});
+    }
+    catch (tmp::CompileError &e)
+    {
+        rejected = std::string(e.what()) == "ERROR::BATCH::NO_VARIABLES";
+    }
+    check(rejected, "Sum over a program without variables");
+
+    std::cout << (failed ? "some checks failed\n" : "all reduction checks passed\n");
+    return failed ? 1 : 0;
+}
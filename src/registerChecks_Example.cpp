@@ -0,0 +1,124 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include "TinyMathParser.h"
+
+// Compares RegisterProgram with Program, returns non zero if any case fails.
+int main()
+{
+    using Op = tmp::RegInstruction::OpCode;
+
+    size_t failed = 0;
+    auto check = [&](bool ok, const std::string &what)
+    {
+        if (!ok)
+        {
+            failed++;
+            std::cout << "FAILED: " << what << '\n';
+        }
+    };
+
+    struct Case
+    {
+        std::string expression;
+        std::vector<Op> uses;    // must appear in the lowered code
+        std::vector<Op> avoids;  // must not appear
+    };
+
+    const std::vector<Case> cases = {
+        // leaves and constant folding
+        {"x", {Op::LoadVar}, {}},
+        {"5", {Op::LoadConst}, {}},
+        {"2*3+4", {Op::LoadConst}, {Op::Add, Op::Mul}},
+        // variable operands
+        {"sin(x)+y", {Op::Sin, Op::AddVar}, {}},
+        {"sin(x)-y", {Op::SubVar}, {}},
+        {"y-sin(x)", {Op::VarSub}, {}},
+        {"sin(x)*y", {Op::MulVar}, {}},
+        {"sin(x)/y", {Op::DivVar}, {}},
+        {"y/sin(x)", {Op::VarDiv}, {}},
+        // constant operands
+        {"cos(x)+2", {Op::Cos, Op::AddConst}, {}},
+        {"cos(x)-2", {Op::SubConst}, {}},
+        {"2-cos(x)", {Op::ConstSub}, {}},
+        {"cos(x)*2", {Op::MulConst}, {}},
+        {"cos(x)/2", {Op::DivConst}, {}},
+        {"2/cos(x)", {Op::ConstDiv}, {}},
+        // plain register forms
+        {"sqrt(x)*tan(y)-x^2", {Op::Sqrt, Op::Tan, Op::Pow}, {}},
+        // fused multiply add / subtract
+        {"(a+b)*(c+d)+(e+f)", {Op::Fma}, {}},
+        {"(a+b)*(c-d)-(e/f)", {Op::Fms}, {}},
+        // Horner only pays off for real polynomials
+        {"3*x*x*x+2*x*x-x+1", {Op::Horner}, {}},
+        {"x*x*x*x-3*x*x+2", {Op::Horner}, {}},
+        {"x*x", {Op::MulVar}, {Op::Horner}},
+        {"x*x+y", {}, {Op::Horner}},
+        {"sqrt(x*x+y*y)/2", {}, {Op::Horner}},
+        {"(x-1000)*(x-1000)*(x-1000)*(x-1000)", {}, {Op::Horner}},
+        {"x*x-x*x+x*x*x", {}, {Op::Horner}},
+        // register reuse
+        {"((a+b)*(c+d))*((e+f)*(g+h))", {Op::Mul}, {}},
+    };
+
+    tmp::Compiler compiler;
+    for (const auto &c : cases)
+    {
+        const tmp::Program program = compiler.Compile(compiler.Parse(c.expression));
+        const tmp::RegisterProgram registers(program);
+        const std::string tag = " for \"" + c.expression + "\"";
+
+        auto has = [&](Op op)
+        {
+            return std::any_of(registers.Code().begin(), registers.Code().end(), [&](const tmp::RegInstruction &in)
+                                { return in.code == op; });
+        };
+        for (Op op : c.uses)
+            check(has(op), "uses opcode " + std::to_string(int(op)) + tag);
+        for (Op op : c.avoids)
+            check(!has(op), "avoids opcode " + std::to_string(int(op)) + tag);
+
+        // values in [0.5, 2.5], where every case is well conditioned
+        std::vector<double> values(program.Variables().size());
+        size_t mismatches = 0;
+        for (size_t sample = 0; sample < 200; sample++)
+        {
+            for (size_t v = 0; v < values.size(); v++)
+                values[v] = 0.5 + std::fmod(0.137 * double(sample + 1) * double(v + 3), 2.0);
+            const double expected = program.Evaluate(values);
+            const double actual = registers.Evaluate(values);
+            if (!(std::fabs(expected - actual) <= 1e-12 * std::max(1.0, std::fabs(expected))))
+                mismatches++;
+        }
+        check(mismatches == 0, std::to_string(mismatches) + " mismatches against Program" + tag);
+    }
+
+    // registers are reused: 11 instructions fit in 3 registers
+    {
+        const tmp::RegisterProgram registers(compiler.Compile(compiler.Parse("((a+b)*(c+d))*((e+f)*(g+h))")));
+        check(registers.RegisterCount() < registers.Code().size(), "registers are reused");
+    }
+
+    // like terms are not merged, so inf - inf still gives NaN
+    {
+        const tmp::Program program = compiler.Compile(compiler.Parse("x*x-x*x+x*x*x"));
+        const tmp::RegisterProgram registers(program);
+        check(std::isnan(program.Evaluate({1e200})) && std::isnan(registers.Evaluate({1e200})), "x*x-x*x+x*x*x at 1e200 is NaN on both");
+    }
+
+    // documented fma contraction: the difference stays within an ulp of 9*x*x*x*7
+    {
+        const tmp::Program program = compiler.Compile(compiler.Parse("((x*7)*x)*((9*x)-(x*9))"));
+        const tmp::RegisterProgram registers(program);
+        const double x = -3.7;
+        check(std::fabs(program.Evaluate({x}) - registers.Evaluate({x})) <= 1e-12 * 63 * std::fabs(x * x * x), "fma contraction stays within rounding of a*b");
+    }
+
+    // an empty Program gives NaN instead of reading past the registers
+    check(std::isnan(tmp::RegisterProgram(tmp::Program()).Evaluate({})), "empty Program gives NaN");
+
+    std::cout << (failed ? "some checks failed\n" : "all register machine checks passed\n");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include "TinyMathServer.h"
+
+// Behaviour checks for EvalServer, returns non zero if any case fails.
+int main()
+{
+    size_t failed = 0;
+    auto check = [&](bool ok, const std::string &what)
+    {
+        if (!ok)
+        {
+            failed++;
+            std::cout << "FAILED: " << what << '\n';
+        }
+    };
+
+    auto rejected = [](std::future<double> future)
+    {
+        try
+        {
+            future.get();
+        }
+        catch (tmp::CompileError &e)
+        {
+            return std::string(e.what()) == "ERROR::SERVER::REQUEST_REJECTED";
+        }
+        return false;
+    };
+
+    // results match Program::Evaluate
+    {
+        tmp::ServerOptions options;
+        options.workers = 3;
+        options.maxBatch = 16;
+        tmp::EvalServer server(options);
+
+        const std::vector<std::string> expressions = {"x*y+z", "sin(x)+cos(y)", "(a+b)*(a-b)/c", "42"};
+        tmp::Compiler compiler;
+        std::vector<tmp::Program> programs;
+        for (uint64_t id = 0; id < expressions.size(); id++)
+        {
+            check(!server.Register(id, expressions[id]), "Register " + expressions[id]);
+            programs.push_back(compiler.Compile(compiler.Parse(expressions[id])));
+        }
+        check(bool(server.Register(99, "3 +")), "Register of a bad expression fails");
+
+        std::vector<std::future<double>> futures;
+        std::vector<double> expected;
+        for (size_t r = 0; r < 1000; r++)
+        {
+            const uint64_t id = r % expressions.size();
+            std::vector<double> values(programs[id].Variables().size());
+            for (size_t v = 0; v < values.size(); v++)
+                values[v] = 0.5 + double(r) * 0.01 + double(v);
+            futures.push_back(server.Submit(id, values));
+            expected.push_back(programs[id].Evaluate(values));
+        }
+        size_t mismatches = 0;
+        for (size_t r = 0; r < futures.size(); r++)
+            mismatches += futures[r].get() == expected[r] ? 0 : 1;
+        check(mismatches == 0, "Submit results match Program::Evaluate (" + std::to_string(mismatches) + " mismatches)");
+
+        // rejections
+        const std::vector<double> two{1.0, 2.0};
+        check(rejected(server.Submit(12345, two)), "unknown id is rejected");
+        check(rejected(server.Submit(0, two)), "wrong value count is rejected");
+        check(rejected(server.Submit(99, two)), "failed Register leaves no entry");
+    }
+
+    // Stop() flushes what is still queued
+    {
+        tmp::ServerOptions options;
+        options.workers = 2;
+        options.maxBatch = 100000;
+        options.latencyBudget = std::chrono::seconds(30); // nothing would be dispatched on its own
+        tmp::EvalServer server(options);
+        server.Register(1, "x+1");
+
+        std::atomic<size_t> replies = 0;
+        const std::vector<double> value{1.0};
+        const size_t count = 500;
+        for (size_t r = 0; r < count; r++)
+            server.Submit(1, value, [&](double v)
+                          { replies += v == 2.0 ? 1 : 0; });
+
+        const auto start = std::chrono::steady_clock::now();
+        server.Stop();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        check(replies == count, "Stop() flushes queued requests (" + std::to_string(replies) + " of " + std::to_string(count) + ")");
+        check(seconds < 10.0, "Stop() does not wait for the latency budget");
+        check(!server.Submit(1, value, [](double) {}), "Submit after Stop() is rejected");
+    }
+
+    std::cout << (failed ? "some checks failed\n" : "all server checks passed\n");
+    return failed ? 1 : 0;
+}
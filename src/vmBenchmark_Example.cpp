@@ -0,0 +1,86 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include "TinyMathParser.h"
+
+// usage: vmBenchmark [iterations]
+// Compares Compiler::Evaluate, the stack Program and the RegisterProgram on a small corpus.
+// rpn and reg are instruction counts, steps counts every fma of a Horner instruction.
+int main(int argc, char *argv[])
+{
+    const size_t iterations = argc > 1 ? std::stoul(argv[1]) : 200000;
+
+    const std::vector<std::string> corpus = {
+        "3*x*x+2*x+1",
+        "a*b+c",
+        "(a+b)*(c+d)+(e+f)",
+        "x*x*x*x-3*x*x+2",
+        "sin(x)*cos(y)+z*2",
+        "a/(b-c)*d-(e+f*g)",
+        "(x+1)*(x-1)*(x+2)",
+        "sqrt(x*x+y*y)/2",
+        "2*3+x*4",
+        "(a+b)*(a-b)/c",
+    };
+
+    using Clock = std::chrono::steady_clock;
+    volatile double sink = 0.0;
+
+    std::cout << std::left << std::setw(22) << "expression"
+              << std::right << std::setw(6) << "rpn" << std::setw(6) << "reg" << std::setw(7) << "steps"
+              << std::setw(14) << "Evaluate ns" << std::setw(12) << "stack ns" << std::setw(12) << "reg ns" << '\n';
+
+    for (const auto &expression : corpus)
+    {
+        tmp::Compiler compiler;
+        auto tokens = compiler.Parse(expression);
+        const tmp::Program program = compiler.Compile(tokens);
+        const tmp::RegisterProgram registers(program);
+
+        // a Horner instruction of degree d runs d fma steps
+        size_t steps = 0;
+        for (const auto &in : registers.Code())
+            steps += in.code == tmp::RegInstruction::OpCode::Horner ? in.degree : 1;
+
+        std::vector<double> values(program.Variables().size());
+        for (size_t v = 0; v < values.size(); v++)
+        {
+            values[v] = 1.0 + 0.25 * double(v);
+            compiler.setVariableValue(tokens, program.Variables()[v], values[v]);
+        }
+
+        // Evaluate redoes the shunting yard on every call, fewer rounds keep it bearable
+        const size_t slowIterations = iterations / 10 ? iterations / 10 : 1;
+        auto start = Clock::now();
+        for (size_t i = 0; i < slowIterations; i++)
+            sink = sink + compiler.Evaluate(tokens);
+        const double evaluateNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / double(slowIterations);
+
+        std::vector<double> stack(program.StackSize());
+        start = Clock::now();
+        for (size_t i = 0; i < iterations; i++)
+        {
+            values[0] += 1e-9;
+            sink = sink + program.Run(values.data(), stack.data());
+        }
+        const double stackNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / double(iterations);
+
+        std::vector<double> regs(registers.RegisterCount());
+        start = Clock::now();
+        for (size_t i = 0; i < iterations; i++)
+        {
+            values[0] += 1e-9;
+            sink = sink + registers.Run(values.data(), regs.data());
+        }
+        const double regNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / double(iterations);
+
+        std::cout << std::left << std::setw(22) << expression
+                  << std::right << std::setw(6) << program.Code().size() << std::setw(6) << registers.Code().size() << std::setw(7) << steps
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(14) << evaluateNs << std::setw(12) << stackNs << std::setw(12) << regNs << '\n';
+    }
+
+    return 0;
+}